@@ -15,6 +15,7 @@
 
 #include <allegro.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <math.h>
 
 #ifdef __cplusplus
@@ -66,11 +67,85 @@ typedef struct {
   glSize n;
 } glPolygonBuffer;
 
+typedef struct {
+  glVertex *verts;
+  glSize n;
+} glVertexBuffer;
+
+/* Per-view results of glRenderViews(), texture
+ * coords are read from the shared glPolygon */
+typedef struct {
+  glVector3f screen[3];
+  glBool backfacing;
+} glViewPolygon;
+
+typedef struct {
+  glViewPolygon *polys;
+  glSize n;
+} glViewBuffer;
+
+/* Binary asset file (see tools/glpack.c), native byte order.
+ * Sections follow the header at 4-byte aligned offsets:
+ *   glMeshVertex verts[nverts]
+ *   uint32_t index[ntris * 3]
+ *   texels of tex_levels mip levels, level k being
+ *   max(tex_w >> k, 1) x max(tex_h >> k, 1), rows packed */
+#define GL_ASSET_MAGIC "NGLA"
+#define GL_ASSET_VERSION 1
+
+typedef struct {
+  glVector3f pos;
+  glVector2f uv; /* [0,1] (no wrapping, glpack clamps tiled
+                  * coords), V pointing down the texture rows */
+} glMeshVertex;
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t nverts, ntris;
+  uint32_t verts_offset;
+  uint32_t index_offset;
+  glVector3f bounds_min, bounds_max;
+  glVector3f center; /* bounding sphere (model space) */
+  float radius;
+  uint32_t tex_w, tex_h;
+  uint32_t tex_bpp; /* bits per texel, frame-buffer pixel format */
+  uint32_t tex_levels; /* 0 if the mesh has no texture */
+  uint32_t tex_offset;
+} glAssetHeader;
+
+/* Mesh rendered straight from the memory-mapped asset file */
+typedef struct {
+  const glMeshVertex *verts;
+  const uint32_t *index;
+  glSize nverts, ntris;
+  glVector3f center;
+  float radius;
+  glTexture *texptr;   /* may be replaced by the application,
+                        * nothing is drawn while GL_NULL */
+  glTexture *texture;  /* loaded from the file, owned by the mesh */
+  void *map;
+  size_t map_size;
+} glMesh;
+
 typedef struct {
   float *depth;
   glSize w, h, n;
 } glDepthBuffer;
 
+/* Deferred texturing, see glDeferred() and glResolve() */
+typedef struct {
+  glTexture **texptr; /* GL_NULL where nothing was drawn */
+  glVector2f *uviz;   /* U/Z and V/Z of the visible surface */
+  glSize w, h, n;
+} glVisibilityBuffer;
+
+/* Incremental rendering, see glIncremental() and glInvalidate() */
+typedef struct {
+  uint8_t *dirty; /* GL_TILE_PENDING and GL_TILE_ACTIVE flags */
+  glSize w, h, n; /* grid size in tiles */
+} glTileBuffer;
+
 typedef struct {
   glVector2f center;
   float plane[3];
@@ -83,6 +158,34 @@ typedef struct {
   glVector3f up;
 } glCamera;
 
+/* Unit of the glStats::cycles_* timers: CPU cycles (rdtsc)
+ * when set, clock() ticks (CLOCKS_PER_SEC per second) if not */
+#if defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+  #define GL_STATS_CYCLES 1
+#else
+  #define GL_STATS_CYCLES 0
+#endif
+
+/* Per-frame counters, filled only when built with GL_STATS.
+ * Reset by glClear() and read back with glGetStats() */
+typedef struct {
+  glSize tris_in;         /* polygons submitted to glRender */
+  glSize tris_culled;     /* rejected as backfacing */
+  glSize tris_thin;       /* too thin to cover any pixel */
+  glSize tris_clean;      /* only covering clean tiles (incremental) */
+  glSize tris_raster;     /* handed to the scanline rasterizer */
+  glSize pixels_tested;   /* sum of the four pixel counters below */
+  glSize pixels_clipped;  /* outside the frame-buffer rect */
+  glSize pixels_frustum;  /* outside near/far planes */
+  glSize pixels_depth;    /* failed the depth test */
+  glSize pixels_written;
+  glSize pixels_resolved; /* texels fetched by glResolve */
+  float overdraw;         /* pixels_written per frame-buffer pixel */
+  uint64_t cycles_transform; /* unit given by GL_STATS_CYCLES */
+  uint64_t cycles_raster;
+  uint64_t cycles_resolve;
+} glStats;
+
 typedef struct {
   glInt state;
   glMatrix worldview;
@@ -90,6 +193,11 @@ typedef struct {
   glFrustum *frustum;
   glTexture *frame_buf;
   glDepthBuffer *depth_buf;
+  glVisibilityBuffer *vis_buf;
+  glTileBuffer *tile_buf;
+  glViewBuffer *view_buf;    /* see glRenderViews() */
+  glVertexBuffer *vert_buf;  /* transformed glMesh vertices */
+  glStats stats;
 } glContext;
 
 GL_EXPORT(glContext*) glInit(void);
@@ -97,6 +205,19 @@ GL_EXPORT(void) glExit(glContext *context);
 GL_EXPORT(void) glClear(glContext *context);
 GL_EXPORT(void) glLookAt(glContext *context, glCamera *camera);
 GL_EXPORT(void) glRender(glContext *context, glPolygonBuffer *object, glMatrix *modelworld);
+GL_EXPORT(void) glRenderViews(glContext **views, glSize n,
+  glPolygonBuffer *object, glMatrix *modelworld);
+GL_EXPORT(glMesh*) glMeshLoad(const char *path, glSize level);
+GL_EXPORT(void) glMeshFree(glMesh *mesh);
+GL_EXPORT(void) glRenderMesh(glContext *context, glMesh *mesh, glMatrix *modelworld);
+GL_EXPORT(glInt) glDeferred(glContext *context, glBool enable);
+GL_EXPORT(void) glResolve(glContext *context);
+GL_EXPORT(glInt) glIncremental(glContext *context, glBool enable);
+GL_EXPORT(void) glInvalidate(glContext *context,
+  glPolygonBuffer *object, glMatrix *modelworld);
+GL_EXPORT(void) glInvalidateMesh(glContext *context,
+  glMesh *mesh, glMatrix *modelworld);
+GL_EXPORT(void) glGetStats(glContext *context, glStats *stats);
 GL_EXPORT(glInt) glPerspective(glContext *context,
   glVector2f *viewport_size, float z_near, float z_far, float fov);
 
@@ -0,0 +1,321 @@
+
+/*
+ *  Graphics Library (GL) using Software Rendering (SR)
+ *  Copyright (C) Andre Caceres Carrilho, 2010-2017
+ *
+ *  This code is a minimalistic version of OpenGL aimed
+ *  at CPU-based perspective projection and rasterization
+ *  of textured triangles. The code is written only for
+ *  single-threaded usage without SIMD or SSE instructions
+ *  and does not follow Khronos Group standards
+ */
+
+/*
+ * Binary assets (glAssetHeader in gl.h): the file is mapped
+ * read-only and the vertex and index sections are used in
+ * place, nothing is parsed or copied at load time. Only the
+ * selected texture level is copied into a glTexture, since
+ * the frame-buffer library owns the bitmap memory.
+ */
+
+#include "gl_common.h"
+
+/* Textures are built from the bitmap rows (BITMAP::line) */
+#if !defined ALLEGRO_H
+  #error Binary assets require the Allegro backend
+#endif
+
+#if defined _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#define _GL_ALIGN4(n) (((n) + 3) & ~((uint64_t) 3))
+
+GL_INTERNAL(void*)
+__glMapFile(const char *path, size_t *size)
+{
+  void *map;
+#if defined _WIN32
+  LARGE_INTEGER len;
+  HANDLE fm, fd = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ,
+    GL_NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, GL_NULL);
+  if (fd == INVALID_HANDLE_VALUE)
+    return GL_NULL;
+  if (!GetFileSizeEx(fd, &len) || len.QuadPart == 0) {
+    CloseHandle(fd);
+    return GL_NULL;
+  }
+  fm = CreateFileMappingA(fd, GL_NULL, PAGE_READONLY, 0, 0, GL_NULL);
+  CloseHandle(fd);
+  if (!fm)
+    return GL_NULL;
+  map = MapViewOfFile(fm, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(fm);
+  *size = (size_t) len.QuadPart;
+#else
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return GL_NULL;
+  if (fstat(fd, &st) || st.st_size == 0) {
+    close(fd);
+    return GL_NULL;
+  }
+  map = mmap(GL_NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return GL_NULL;
+  *size = (size_t) st.st_size;
+#endif
+  return map;
+}
+
+GL_INTERNAL(void)
+__glUnmapFile(void *map, size_t size)
+{
+#if defined _WIN32
+  (void) size;
+  UnmapViewOfFile(map);
+#else
+  munmap(map, size);
+#endif
+}
+
+/* Byte offset of a mip level from tex_offset */
+GL_INTERNAL(uint64_t)
+__glAssetLevel(const glAssetHeader *hd, glSize level,
+               glSize *w, glSize *h)
+{
+  glSize k;
+  uint64_t offset = 0;
+  for (k = 0; ; ++k) {
+    *w = hd->tex_w >> k ? hd->tex_w >> k : 1;
+    *h = hd->tex_h >> k ? hd->tex_h >> k : 1;
+    if (k == level)
+      return offset;
+    offset += _GL_ALIGN4((uint64_t) *w * *h * (hd->tex_bpp / 8));
+  }
+}
+
+/* Sanity checks, so that a truncated or foreign
+ * file can not make the renderer read out of the map */
+GL_INTERNAL(glInt)
+__glAssetCheck(const glAssetHeader *hd, size_t size)
+{
+  glSize w, h, i;
+  const uint32_t *index;
+  if (size < sizeof(glAssetHeader))
+    return -1;
+  if (memcmp(hd->magic, GL_ASSET_MAGIC, 4) ||
+      hd->version != GL_ASSET_VERSION)
+    return -1;
+  if ((hd->verts_offset & 3) || (hd->index_offset & 3) ||
+      (hd->tex_offset & 3))
+    return -1;
+  if ((uint64_t) hd->verts_offset +
+      (uint64_t) hd->nverts * sizeof(glMeshVertex) > size)
+    return -1;
+  if ((uint64_t) hd->index_offset +
+      (uint64_t) hd->ntris * 3 * sizeof(uint32_t) > size)
+    return -1;
+  if (hd->tex_levels) {
+    if (hd->tex_bpp != GL_COLOR_DEPTH || !hd->tex_w || !hd->tex_h ||
+        hd->tex_levels > 16)
+      return -1;
+    if ((uint64_t) hd->tex_offset +
+        __glAssetLevel(hd, hd->tex_levels, &w, &h) > size)
+      return -1;
+  }
+  /* A single pass over the indices, the only O(n) work on load */
+  index = (const uint32_t*) ((const char*) hd + hd->index_offset);
+  for (i = 0; i < hd->ntris * 3; ++i) {
+    if (index[i] >= hd->nverts)
+      return -1;
+  }
+  return 0;
+}
+
+GL_INTERNAL(glTexture*)
+__glAssetTexture(const glAssetHeader *hd, glSize level)
+{
+  glSize w, h, y, pitch;
+  const char *texels = (const char*) hd + hd->tex_offset +
+    __glAssetLevel(hd, level, &w, &h);
+  pitch = w * (hd->tex_bpp / 8);
+  glTexture *tex = create_bitmap(w, h);
+  if (!tex)
+    return GL_NULL;
+  if (bitmap_color_depth(tex) != (int) hd->tex_bpp) {
+    destroy_bitmap(tex);
+    return GL_NULL;
+  }
+  for (y = 0; y < h; ++y)
+    memcpy(tex->line[y], texels + y * pitch, pitch);
+  return tex;
+}
+
+/* Level selects the mip level used as texture (clamped) */
+GL_EXPORT(glMesh*)
+glMeshLoad(const char *path, glSize level)
+{
+  size_t size;
+  const glAssetHeader *hd;
+  glMesh *mesh;
+  void *map;
+  if (!path)
+    return GL_NULL;
+  map = __glMapFile(path, &size);
+  if (!map)
+    return GL_NULL;
+  hd = (const glAssetHeader*) map;
+  if (__glAssetCheck(hd, size)) {
+    __glUnmapFile(map, size);
+    return GL_NULL;
+  }
+  mesh = (glMesh*) malloc(sizeof(glMesh));
+  if (!mesh) {
+    __glUnmapFile(map, size);
+    return GL_NULL;
+  }
+  mesh->map = map;
+  mesh->map_size = size;
+  mesh->verts = (const glMeshVertex*) ((const char*) map + hd->verts_offset);
+  mesh->index = (const uint32_t*) ((const char*) map + hd->index_offset);
+  mesh->nverts = hd->nverts;
+  mesh->ntris = hd->ntris;
+  mesh->center = hd->center;
+  mesh->radius = hd->radius;
+  mesh->texture = GL_NULL;
+  if (hd->tex_levels) {
+    if (level >= hd->tex_levels)
+      level = hd->tex_levels - 1;
+    mesh->texture = __glAssetTexture(hd, level);
+    if (!mesh->texture) {
+      glMeshFree(mesh);
+      return GL_NULL;
+    }
+  }
+  mesh->texptr = mesh->texture;
+  return mesh;
+}
+
+GL_EXPORT(void)
+glMeshFree(glMesh *mesh)
+{
+  if (mesh) {
+    if (mesh->texture)
+      destroy_bitmap(mesh->texture);
+    if (mesh->map)
+      __glUnmapFile(mesh->map, mesh->map_size);
+    free(mesh);
+  }
+}
+
+/* Bounding sphere of the mesh in view space, returns the radius */
+GL_INTERNAL(float)
+__glMeshSphere(glContext *ctx, glMesh *mesh, glMatrix *mw,
+               glVector3f *center)
+{
+  unsigned int j;
+  float s, r = mesh->radius;
+  glVector3f world;
+  if (mw) {
+    __glMathProductPtr(world, mw, mesh->center)
+    /* Largest axis scale of the model-world matrix */
+    for (r = 0.0f, j = 0; j < 3; ++j) {
+      s = sqrtf(mw->m[0][j] * mw->m[0][j] +
+                mw->m[1][j] * mw->m[1][j] +
+                mw->m[2][j] * mw->m[2][j]);
+      if (s * mesh->radius > r)
+        r = s * mesh->radius;
+    }
+  } else {
+    __glMathAssign(world, mesh->center)
+  }
+  __glMathProductVar((*center), ctx->worldview, world)
+  return r;
+}
+
+/* Same stages as glRender(), but every shared vertex is
+ * transformed only once and the polygons are assembled on
+ * the fly from the index section */
+#define _GL_CVERT vb->verts[i]
+GL_EXPORT(void)
+glRenderMesh(glContext *context, glMesh *mesh, glMatrix *modelworld)
+{
+  unsigned int i, j;
+  float __rp;
+  glVector3f world, center, edge1, edge2, normal;
+  glVector2f uv_scale;
+  glPolygon p;
+  if (!context || !mesh || !mesh->texptr)
+    return;
+  if (context->state < GL_READY)
+    return;
+  glFrustum *ft = context->frustum;
+  /* *********************************
+   * Bounding sphere vs near/far planes
+   * *********************************/
+  __rp = __glMeshSphere(context, mesh, modelworld, &center);
+  if (center.z + __rp <= ft->plane[GL_PLANE_NEAR] ||
+      center.z - __rp >= ft->plane[GL_PLANE_FAR])
+    return;
+  if (__glVertBufferReserve(context, mesh->nverts))
+    return;
+  glVertexBuffer *vb = context->vert_buf;
+  /* [0,1] to texel units of the current texture, which the
+   * application may have swapped since glMeshLoad(). Keeps
+   * (int) u and (int) v inside the texture */
+  uv_scale.x = (float) (mesh->texptr->w - 1);
+  uv_scale.y = (float) (mesh->texptr->h - 1);
+  __glStatsAdd(context, tris_in, mesh->ntris)
+  __glStatsBegin(t_transform)
+  /* *********************************
+   * Model-World-View-Screen transformation
+   * *********************************/
+  for (i = 0; i < mesh->nverts; ++i) {
+    if (modelworld) {
+      __glMathProductPtr(world, modelworld, mesh->verts[i].pos)
+    } else {
+      __glMathAssign(world, mesh->verts[i].pos)
+    }
+    __glMathProductVar(_GL_CVERT.view, context->worldview, world)
+    __rp = ft->plane[GL_PLANE_PROJECTION] / _GL_CVERT.view.z;
+    _GL_CVERT.screen.x = _GL_CVERT.view.x * __rp + ft->center.x;
+    _GL_CVERT.screen.y = _GL_CVERT.view.y * __rp + ft->center.y;
+    _GL_CVERT.screen.z = _GL_CVERT.view.z;
+    _GL_CVERT.texture.x = mesh->verts[i].uv.x * uv_scale.x;
+    _GL_CVERT.texture.y = mesh->verts[i].uv.y * uv_scale.y;
+  }
+  __glStatsEnd(context, cycles_transform, t_transform)
+  __glStatsBegin(t_raster)
+  p.texptr = mesh->texptr;
+  p.backfacing = 0;
+  for (i = 0; i < mesh->ntris; ++i) {
+    const uint32_t *tri = &mesh->index[i * 3];
+    /* *********************************
+     * Backface culling
+     * *********************************/
+    __glMathSubtract(edge1, vb->verts[tri[1]].view, vb->verts[tri[0]].view)
+    __glMathSubtract(edge2, vb->verts[tri[2]].view, vb->verts[tri[0]].view)
+    __glMathCrossProduct(normal, edge1, edge2)
+    /* Only the sign of the cosine matters here,
+     * no need to normalize as __glWorldScreen() does */
+    if (__glMathDotProduct(vb->verts[tri[0]].view, normal) < 0.0f) {
+      __glStatsAdd(context, tris_culled, 1)
+      continue;
+    }
+    for (j = 0; j < 3; ++j)
+      p.verts[j] = vb->verts[tri[j]];
+    if (context->tile_buf && !__glTileTest(context, &p))
+      continue;
+    __glRasterPolygon(context, &p);
+  }
+  __glStatsEnd(context, cycles_raster, t_raster)
+}
+#undef _GL_CVERT
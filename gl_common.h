@@ -14,6 +14,7 @@
 #define __gl_common__
 
 #include "gl.h"
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,22 +24,88 @@ extern "C" {
 
 #define GL_FAST_MATH
 
+/* Enables the counters read by glGetStats(),
+ * compiled out entirely when not defined */
+// #define GL_STATS
+
 #define GL_NULL 0
 #define GL_CREATED 1
 #define GL_READY 2
 
+/* Incremental rendering tiles (32x32 pixels) */
+#define GL_TILE_SHIFT 5
+#define GL_TILE_SIZE (1 << GL_TILE_SHIFT)
+#define GL_TILE_PENDING 1 /* invalidated for the next glClear */
+#define GL_TILE_ACTIVE 2  /* being redrawn in the current frame */
+
 #define GL_PLANE_NEAR 0
 #define GL_PLANE_FAR 1
 #define GL_PLANE_PROJECTION 2
 
+#ifdef GL_STATS
+  #include <time.h>
+  #if GL_STATS_CYCLES
+    #define __glStatsClock() ((uint64_t) __builtin_ia32_rdtsc())
+  #else
+    #define __glStatsClock() ((uint64_t) clock())
+  #endif
+  #define __glStatsAdd(ctx, field, k) \
+    (ctx)->stats.field += (k);
+  #define __glStatsBegin(t) \
+    uint64_t t = __glStatsClock();
+  #define __glStatsEnd(ctx, field, t) \
+    (ctx)->stats.field += __glStatsClock() - (t);
+#else
+  #define __glStatsAdd(ctx, field, k)
+  #define __glStatsBegin(t)
+  #define __glStatsEnd(ctx, field, t)
+#endif
+
 GL_INTERNAL(float) __glRsqrt(float);
 GL_INTERNAL(void) __glNormalize(glVector3f*);
 GL_INTERNAL(void) __glWorldViewMatrix(glCamera*, glMatrix*);
+GL_INTERNAL(glVisibilityBuffer*) __glVisibilityBufferCreate(glSize w,
+                                                            glSize h);
+GL_INTERNAL(void) __glVisibilityBufferFree(glVisibilityBuffer *vb);
+GL_INTERNAL(glTileBuffer*) __glTileBufferCreate(glSize w, glSize h);
+GL_INTERNAL(void) __glTileBufferFree(glTileBuffer *tb);
+GL_INTERNAL(glInt) __glTileBounds(glContext *ctx, glPolygon *p, int *r);
+GL_INTERNAL(glInt) __glTileRect(glContext *ctx, float x1, float y1,
+                                float x2, float y2, int *r);
+GL_INTERNAL(void) __glTileMark(glTileBuffer *tb, int *r);
+GL_INTERNAL(glBool) __glTileTest(glContext *ctx, glPolygon *p);
+GL_INTERNAL(void) __glTileForEach(glContext *ctx,
+  void (*fn)(glContext*, int, int, int, int));
+GL_INTERNAL(void) __glClearTiles(glContext *ctx);
+GL_INTERNAL(void) __glTileRedrawAll(glContext *ctx);
+GL_INTERNAL(void) __glClearRect(glContext *ctx, int x1, int y1,
+                                int x2, int y2);
+GL_INTERNAL(void) __glResolveRect(glContext *ctx, int x1, int y1,
+                                  int x2, int y2);
+GL_INTERNAL(glInt) __glViewBufferReserve(glContext *ctx, glSize n);
+GL_INTERNAL(glInt) __glVertBufferReserve(glContext *ctx, glSize n);
+GL_INTERNAL(void*) __glMapFile(const char *path, size_t *size);
+GL_INTERNAL(void) __glUnmapFile(void *map, size_t size);
+GL_INTERNAL(uint64_t) __glAssetLevel(const glAssetHeader *hd,
+                                     glSize level, glSize *w, glSize *h);
+GL_INTERNAL(glInt) __glAssetCheck(const glAssetHeader *hd, size_t size);
+GL_INTERNAL(glTexture*) __glAssetTexture(const glAssetHeader *hd,
+                                         glSize level);
+GL_INTERNAL(float) __glMeshSphere(glContext *ctx, glMesh *mesh,
+                                  glMatrix *mw, glVector3f *center);
 GL_INTERNAL(void) __glRenderPipeline(glContext *,
                             glPolygonBuffer *, glMatrix *);
+GL_INTERNAL(void) __glModelWorld(glPolygonBuffer *, glMatrix *);
+GL_INTERNAL(void) __glWorldScreen(glContext *, glPolygonBuffer *);
+GL_INTERNAL(void) __glViewScreen(glContext *,
+                            glPolygonBuffer *, glViewPolygon *);
+GL_INTERNAL(void) __glRasterBuffer(glContext *ctx, glPolygonBuffer *b,
+                                   glSize n);
+GL_INTERNAL(void) __glRasterViews(glContext *ctx, glPolygonBuffer *obj,
+                                  glViewPolygon *views);
 GL_INTERNAL(void) __glRasterPolygon(glContext* ctx, glPolygon *p);
 GL_INTERNAL(void) __glRasterSegment(glContext *ctx, glPolygon *p,
-                                    int y1, int y2);
+                                    float *sp, int y1, int y2);
 GL_INTERNAL(short) __glGetPixelBilinear(glTexture* img,
                                    float dx, float dy);
 
@@ -24,7 +24,12 @@ glInit(void)
     return 0;
   ctx->frame_buf = GL_NULL;
   ctx->depth_buf = GL_NULL;
+  ctx->vis_buf = GL_NULL;
+  ctx->tile_buf = GL_NULL;
+  ctx->view_buf = GL_NULL;
+  ctx->vert_buf = GL_NULL;
   ctx->state = GL_NULL;
+  memset(&ctx->stats, 0, sizeof(glStats));
   return ctx;
 }
 
@@ -37,6 +42,18 @@ glExit(glContext *context)
         free(context->depth_buf->depth);
       free(context->depth_buf);
     }
+    __glVisibilityBufferFree(context->vis_buf);
+    __glTileBufferFree(context->tile_buf);
+    if (context->view_buf) {
+      if (context->view_buf->polys)
+        free(context->view_buf->polys);
+      free(context->view_buf);
+    }
+    if (context->vert_buf) {
+      if (context->vert_buf->verts)
+        free(context->vert_buf->verts);
+      free(context->vert_buf);
+    }
     free(context);
     context = GL_NULL;
   }
@@ -49,9 +66,14 @@ glLookAt(glContext *context, glCamera *camera)
     return;
   if (context->state < GL_CREATED)
     return;
+  glMatrix previous = context->worldview;
   context->camera = camera;
-  context->state = GL_READY;
   __glWorldViewMatrix(context->camera, &context->worldview);
+  /* Camera moved, no retained tile is valid anymore */
+  if (context->tile_buf && (context->state < GL_READY ||
+      memcmp(&previous, &context->worldview, sizeof(glMatrix))))
+    __glTileRedrawAll(context);
+  context->state = GL_READY;
 }
 
 GL_EXPORT(void)
@@ -62,10 +84,22 @@ glClear(glContext *context)
     return;
   if (context->state < GL_CREATED)
     return;
+  /* New frame, restart the counters */
+  memset(&context->stats, 0, sizeof(glStats));
+  /* Incremental, only the invalidated tiles */
+  if (context->tile_buf) {
+    __glClearTiles(context);
+    return;
+  }
   /* Clearing the depth buffer */
   for (i = 0; i < context->depth_buf->n; ++i) {
     context->depth_buf->depth[i] = context->frustum->plane[GL_PLANE_FAR];
   }
+  /* Clearing the visibility buffer (deferred texturing) */
+  if (context->vis_buf) {
+    memset(context->vis_buf->texptr, 0,
+      context->vis_buf->n * sizeof(glTexture*));
+  }
   /* Clearing the frame buffer */
 #if defined ALLEGRO_H
 /*! FIXME */
@@ -76,20 +110,191 @@ glClear(glContext *context)
 #endif
 }
 
+/* Same as glClear(), restricted to a
+ * pixel rect (x2 and y2 exclusive) */
+GL_INTERNAL(void)
+__glClearRect(glContext *ctx, int x1, int y1, int x2, int y2)
+{
+  int x, y, i;
+  for (y = y1; y < y2; ++y) {
+    i = y * ctx->depth_buf->w + x1;
+    if (ctx->vis_buf) {
+      memset(&ctx->vis_buf->texptr[i], 0,
+        (x2 - x1) * sizeof(glTexture*));
+    }
+    for (x = x1; x < x2; ++x, ++i) {
+      ctx->depth_buf->depth[i] = ctx->frustum->plane[GL_PLANE_FAR];
+    }
+  }
+#if defined ALLEGRO_H
+  rectfill(ctx->frame_buf, x1, y1, x2 - 1, y2 - 1, makecol(60, 60, 60));
+#elif defined _SDL_H
+  SDL_Rect rect = { x1, y1, x2 - x1, y2 - y1 };
+  SDL_RenderFillRect(renderer, &rect);
+#endif
+}
+
 GL_EXPORT(void)
 glRender(glContext *context, glPolygonBuffer *object, glMatrix *modelworld)
 {
-  unsigned int i;
   if (!context || !object)
     return;
   if (context->state < GL_READY)
     return;
+  __glStatsAdd(context, tris_in, object->n)
+  __glStatsBegin(t_transform)
   __glRenderPipeline(context, object, modelworld);
-  for (i = 0; i < object->n; ++i) {
-    if (!object->polys[i].backfacing) {
-      __glRasterPolygon(context, &object->polys[i]);
-    }
+  __glStatsEnd(context, cycles_transform, t_transform)
+  __glStatsBegin(t_raster)
+  __glRasterBuffer(context, object, object->n);
+  __glStatsEnd(context, cycles_raster, t_raster)
+}
+
+/* Renders the object into several distinct contexts (cameras).
+ * The model-world transformation is computed once, then every
+ * view projects into its own compact results and rasterizes on
+ * its own buffers, in parallel when built with OpenMP */
+GL_EXPORT(void)
+glRenderViews(glContext **views, glSize n,
+  glPolygonBuffer *object, glMatrix *modelworld)
+{
+  int v;
+  if (!views || !object)
+    return;
+  __glModelWorld(object, modelworld);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (v = 0; v < (int) n; ++v) {
+    glContext *ctx = views[v];
+    if (!ctx || ctx->state < GL_READY)
+      continue;
+    if (__glViewBufferReserve(ctx, object->n))
+      continue;
+    __glStatsAdd(ctx, tris_in, object->n)
+    __glStatsBegin(t_transform)
+    __glViewScreen(ctx, object, ctx->view_buf->polys);
+    __glStatsEnd(ctx, cycles_transform, t_transform)
+    __glStatsBegin(t_raster)
+    __glRasterViews(ctx, object, ctx->view_buf->polys);
+    __glStatsEnd(ctx, cycles_raster, t_raster)
+  }
+}
+
+/* Grows the per-view results to hold at least n polygons */
+GL_INTERNAL(glInt)
+__glViewBufferReserve(glContext *ctx, glSize n)
+{
+  glViewPolygon *polys;
+  glViewBuffer *pb = ctx->view_buf;
+  if (pb && pb->n >= n)
+    return 0;
+  if (!pb) {
+    pb = (glViewBuffer*) malloc(sizeof(glViewBuffer));
+    if (!pb)
+      return -1;
+    pb->polys = GL_NULL;
+    pb->n = 0;
+    ctx->view_buf = pb;
   }
+  polys = (glViewPolygon*) realloc(pb->polys, n * sizeof(glViewPolygon));
+  if (!polys)
+    return -1;
+  pb->polys = polys;
+  pb->n = n;
+  return 0;
+}
+
+/* Grows the glMesh vertex scratch to hold at least n vertices */
+GL_INTERNAL(glInt)
+__glVertBufferReserve(glContext *ctx, glSize n)
+{
+  glVertex *verts;
+  glVertexBuffer *vb = ctx->vert_buf;
+  if (vb && vb->n >= n)
+    return 0;
+  if (!vb) {
+    vb = (glVertexBuffer*) malloc(sizeof(glVertexBuffer));
+    if (!vb)
+      return -1;
+    vb->verts = GL_NULL;
+    vb->n = 0;
+    ctx->vert_buf = vb;
+  }
+  verts = (glVertex*) realloc(vb->verts, n * sizeof(glVertex));
+  if (!verts)
+    return -1;
+  vb->verts = verts;
+  vb->n = n;
+  return 0;
+}
+
+GL_EXPORT(glInt)
+glDeferred(glContext *context, glBool enable)
+{
+  if (!context)
+    return -1;
+  if (!enable) {
+    __glVisibilityBufferFree(context->vis_buf);
+    context->vis_buf = GL_NULL;
+    return 0;
+  }
+  /* Needs the viewport size from glPerspective() */
+  if (context->state < GL_CREATED)
+    return -1;
+  if (context->vis_buf)
+    return 0;
+  context->vis_buf = __glVisibilityBufferCreate(
+    context->depth_buf->w, context->depth_buf->h);
+  if (!context->vis_buf)
+    return -1;
+  return 0;
+}
+
+GL_INTERNAL(glVisibilityBuffer*)
+__glVisibilityBufferCreate(glSize w, glSize h)
+{
+  glVisibilityBuffer *vb =
+    (glVisibilityBuffer*) malloc(sizeof(glVisibilityBuffer));
+  if (!vb)
+    return GL_NULL;
+  vb->w = w;
+  vb->h = h;
+  vb->n = w * h; /* pixel count */
+  vb->texptr = (glTexture**) malloc(vb->n * sizeof(glTexture*));
+  vb->uviz = (glVector2f*) malloc(vb->n * sizeof(glVector2f));
+  if (!vb->texptr || !vb->uviz) {
+    __glVisibilityBufferFree(vb);
+    return GL_NULL;
+  }
+  /* Nothing drawn yet, glResolve() skips every pixel */
+  memset(vb->texptr, 0, vb->n * sizeof(glTexture*));
+  return vb;
+}
+
+GL_INTERNAL(void)
+__glVisibilityBufferFree(glVisibilityBuffer *vb)
+{
+  if (vb) {
+    if (vb->texptr)
+      free(vb->texptr);
+    if (vb->uviz)
+      free(vb->uviz);
+    free(vb);
+  }
+}
+
+GL_EXPORT(void)
+glGetStats(glContext *context, glStats *stats)
+{
+  if (!context || !stats)
+    return;
+  *stats = context->stats;
+  stats->pixels_tested = stats->pixels_clipped +
+    stats->pixels_frustum + stats->pixels_depth + stats->pixels_written;
+  stats->overdraw = 0.0f;
+  if (context->depth_buf && context->depth_buf->n)
+    stats->overdraw = (float) stats->pixels_written / context->depth_buf->n;
 }
 
 GL_EXPORT(int)
@@ -152,6 +357,24 @@ glPerspective(glContext *context, glVector2f *viewport_size,
   db->n = db->w * db->h; /* pixel count */
   db->depth = (float*) malloc(db->n * sizeof(float));
   context->depth_buf = db;
+  /* *********************************
+   * Resetting the Visibility Buffer
+   * *********************************/
+  if (context->vis_buf) {
+    __glVisibilityBufferFree(context->vis_buf);
+    context->vis_buf = __glVisibilityBufferCreate(db->w, db->h);
+    if (!context->vis_buf)
+      return -1;
+  }
+  /* *********************************
+   * Resetting the Tile Buffer
+   * *********************************/
+  if (context->tile_buf) {
+    __glTileBufferFree(context->tile_buf);
+    context->tile_buf = __glTileBufferCreate(db->w, db->h);
+    if (!context->tile_buf)
+      return -1;
+  }
   context->state = GL_CREATED;
   return 0;
 }
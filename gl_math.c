@@ -81,22 +81,47 @@ __glWorldViewMatrix(glCamera *__cam, glMatrix *__wvm)
 GL_INTERNAL(void)
 __glRenderPipeline(glContext *ctx, glPolygonBuffer *obj, glMatrix *mw)
 {
-  unsigned int i, j; float __rp;
-  glVector3f edge1, edge2, delta;
+  __glModelWorld(obj, mw);
+  __glWorldScreen(ctx, obj);
+}
+
+/* Camera independent part of the pipeline, shared by every
+ * view in glRenderViews() */
+GL_INTERNAL(void)
+__glModelWorld(glPolygonBuffer *obj, glMatrix *mw)
+{
+  unsigned int i, j;
   for (i = 0; i < obj->n; ++i) {
   /* *********************************
-   * Model-World-View transformation
+   * Model-World transformation
    * *********************************/
     if (!mw) {
       for (j = 0; j < 3; ++j) {
         /* Not specified model-world transformation */
-        __glMathProductVar(_GL_CVERT.view, ctx->worldview, _GL_CVERT.model)
+        __glMathAssign(_GL_CVERT.world, _GL_CVERT.model)
     } }
     else {
       for (j = 0; j < 3; ++j) {
         __glMathProductPtr(_GL_CVERT.world, mw, _GL_CVERT.model)
-        __glMathProductVar(_GL_CVERT.view, ctx->worldview, _GL_CVERT.world)
     } }
+  }
+}
+#undef _GL_CVERT
+
+/* Camera dependent part of the pipeline, in place */
+#define _GL_CVERT obj->polys[i].verts[j]
+GL_INTERNAL(void)
+__glWorldScreen(glContext *ctx, glPolygonBuffer *obj)
+{
+  unsigned int i, j; float __rp;
+  glVector3f edge1, edge2, delta;
+  for (i = 0; i < obj->n; ++i) {
+  /* *********************************
+   * World-View transformation
+   * *********************************/
+    for (j = 0; j < 3; ++j) {
+      __glMathProductVar(_GL_CVERT.view, ctx->worldview, _GL_CVERT.world)
+    }
   /* *********************************
    * Normal vector (View space)
    * *********************************/
@@ -139,8 +164,10 @@ __glRenderPipeline(glContext *ctx, glPolygonBuffer *obj, glMatrix *mw)
      * If backfacing, the computed cosine will be negative */
       __rp = __glMathDotProduct(delta, obj->polys[i].normal);
       obj->polys[i].backfacing = (__rp < 0.0f) ? (1) : (0);
-      if (obj->polys[i].backfacing)
+      if (obj->polys[i].backfacing) {
+        __glStatsAdd(ctx, tris_culled, 1)
         continue;
+      }
   /* *********************************
    * View-Screen transformation
    * *********************************/
@@ -159,3 +186,36 @@ __glRenderPipeline(glContext *ctx, glPolygonBuffer *obj, glMatrix *mw)
   }
 }
 #undef _GL_CVERT
+
+/* Camera dependent part of the pipeline for glRenderViews().
+ * The shared object is only read, the per-view results (screen
+ * coords and backfacing flag) go to the compact out array */
+GL_INTERNAL(void)
+__glViewScreen(glContext *ctx, glPolygonBuffer *obj, glViewPolygon *out)
+{
+  unsigned int i, j; float __rp;
+  glVector3f view[3], edge1, edge2, normal;
+  glFrustum *ft = ctx->frustum;
+  for (i = 0; i < obj->n; ++i) {
+    for (j = 0; j < 3; ++j) {
+      __glMathProductVar(view[j], ctx->worldview,
+                         obj->polys[i].verts[j].world)
+    }
+    /* Backface culling, only the sign of the cosine
+     * matters so neither vector is normalized */
+    __glMathSubtract(edge1, view[1], view[0])
+    __glMathSubtract(edge2, view[2], view[0])
+    __glMathCrossProduct(normal, edge1, edge2)
+    out[i].backfacing = (__glMathDotProduct(view[0], normal) < 0.0f);
+    if (out[i].backfacing) {
+      __glStatsAdd(ctx, tris_culled, 1)
+      continue;
+    }
+    for (j = 0; j < 3; ++j) {
+      __rp = ft->plane[GL_PLANE_PROJECTION] / view[j].z;
+      out[i].screen[j].x = view[j].x * __rp + ft->center.x;
+      out[i].screen[j].y = view[j].y * __rp + ft->center.y;
+      out[i].screen[j].z = view[j].z;
+    }
+  }
+}
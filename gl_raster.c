@@ -41,11 +41,49 @@
 #define S_DVIZDYA   14
 #define S_DIZDYA    15
 
-static float sp[16];
+/* Rasterizes the first n polygons of the buffer, skipping
+ * the backfacing ones and, in incremental mode, those
+ * outside the invalidated tiles */
+GL_INTERNAL (void)
+__glRasterBuffer (glContext *ctx, glPolygonBuffer *b, glSize n)
+{
+  unsigned int i;
+  for (i = 0; i < n; ++i) {
+    if (b->polys[i].backfacing)
+      continue;
+    if (ctx->tile_buf && !__glTileTest (ctx, &b->polys[i]))
+      continue;
+    __glRasterPolygon (ctx, &b->polys[i]);
+  }
+}
+
+/* Same as __glRasterBuffer for glRenderViews(): screen coords
+ * come from the per-view results, textures from the object */
+GL_INTERNAL (void)
+__glRasterViews (glContext *ctx, glPolygonBuffer *obj, glViewPolygon *views)
+{
+  unsigned int i, j;
+  glPolygon p;
+  for (i = 0; i < obj->n; ++i) {
+    if (views[i].backfacing)
+      continue;
+    p.texptr = obj->polys[i].texptr;
+    for (j = 0; j < 3; ++j) {
+      p.verts[j].screen = views[i].screen[j];
+      p.verts[j].texture = obj->polys[i].verts[j].texture;
+    }
+    if (ctx->tile_buf && !__glTileTest (ctx, &p))
+      continue;
+    __glRasterPolygon (ctx, &p);
+  }
+}
 
 GL_INTERNAL (void)
 __glRasterPolygon (glContext* ctx, glPolygon *p)
 {
+  /* Setup is kept on the stack so that several
+   * contexts can be rasterized at the same time */
+  float sp[16];
 
   /* Shift XY coordinate system (+0.5, +0.5) to
    * match the subpixeling technique */
@@ -105,8 +143,11 @@ __glRasterPolygon (glContext* ctx, glPolygon *p)
   int y3i = y3;
 
   /* Skip poly if it's too thin to cover any pixels at all */
-  if (y1i == y2i && y1i == y3i)
+  if (y1i == y2i && y1i == y3i) {
+    __glStatsAdd(ctx, tris_thin, 1)
     return;
+  }
+  __glStatsAdd(ctx, tris_raster, 1)
 
   /* Calculate horizontal and vertical increments for UV axes (these
     calcs are certainly not optimal, although they're stable
@@ -161,14 +202,14 @@ __glRasterPolygon (glContext* ctx, glPolygon *p)
       sp[S_XB] = x1 + dy * dxdy1;
       sp[S_DXDYB] = dxdy1;
 
-      __glRasterSegment (ctx, p, y1i, y2i);
+      __glRasterSegment (ctx, p, sp, y1i, y2i);
     }
     if (y2i < y3i) { /* Draw lower segment if possibly visible */
       /* Set right edge X-slope and perform subpixel pre-stepping */
       sp[S_XB] = x2 + (1 - (y2 - y2i) ) * dxdy3;
       sp[S_DXDYB] = dxdy3;
 
-      __glRasterSegment (ctx, p, y2i, y3i);
+      __glRasterSegment (ctx, p, sp, y2i, y3i);
     }
   } else { /* Longer edge is on the right side */
     dy = 1 - (y1 - y1i);
@@ -188,7 +229,7 @@ __glRasterPolygon (glContext* ctx, glPolygon *p)
       sp[S_UIZA] = uiz1 + dy * sp[S_DUIZDYA];
       sp[S_VIZA] = viz1 + dy * sp[S_DVIZDYA];
 
-      __glRasterSegment (ctx, p, y1i, y2i);
+      __glRasterSegment (ctx, p, sp, y1i, y2i);
     }
     if (y2i < y3i) { /* Draw lower segment if possibly visible */
       /* Set slopes along left edge and perform subpixel pre-stepping */
@@ -204,17 +245,18 @@ __glRasterPolygon (glContext* ctx, glPolygon *p)
       sp[S_UIZA] = uiz2 + dy * sp[S_DUIZDYA];
       sp[S_VIZA] = viz2 + dy * sp[S_DVIZDYA];
 
-      __glRasterSegment (ctx, p, y2i, y3i);
+      __glRasterSegment (ctx, p, sp, y2i, y3i);
     }
   }
 }
 
 GL_INTERNAL (void)
-__glRasterSegment (glContext *ctx, glPolygon *p, int y1, int y2)
+__glRasterSegment (glContext *ctx, glPolygon *p, float *sp, int y1, int y2)
 {
   int x1, x2, xclip, yclip, zid;
   float z, u, v, dx;
   float iz, uiz, viz;
+  glVisibilityBuffer *vb = ctx->vis_buf;
 
   while (y1 < y2) {
     x1 = sp[S_XA];
@@ -234,25 +276,39 @@ __glRasterSegment (glContext *ctx, glPolygon *p, int y1, int y2)
 
     while (x1++ < x2) {
       z = 1 / iz;
-      u = uiz * z;
-      v = viz * z;
 
       zid++;
 
       /* Clipping the frame-buffer rect (X-axis) */
       xclip = x1 >= 0 && x1 < ctx->frame_buf->w;
 
-      if (xclip && yclip &&
-          /* Clipping near and far planes (frustum) */
-          z > ctx->frustum->plane[GL_PLANE_NEAR] &&
-          z < ctx->frustum->plane[GL_PLANE_FAR]) {
-        /* Z-Buffer sort (depth) */
-        if (z < ctx->depth_buf->depth[zid]) {
-          ctx->depth_buf->depth[zid] = z;
+      if (!xclip || !yclip) {
+        __glStatsAdd(ctx, pixels_clipped, 1)
+      }
+      /* Clipping near and far planes (frustum) */
+      else if (z <= ctx->frustum->plane[GL_PLANE_NEAR] ||
+               z >= ctx->frustum->plane[GL_PLANE_FAR]) {
+        __glStatsAdd(ctx, pixels_frustum, 1)
+      }
+      /* Z-Buffer sort (depth) */
+      else if (z < ctx->depth_buf->depth[zid]) {
+        ctx->depth_buf->depth[zid] = z;
+        if (vb) {
+          /* Deferred, texel is fetched later by glResolve() */
+          vb->texptr[zid] = p->texptr;
+          vb->uviz[zid].x = uiz;
+          vb->uviz[zid].y = viz;
+        } else {
+          u = uiz * z;
+          v = viz * z;
           /* Nearest Neighbour */
           (_GL_RAWPTR ctx->frame_buf->line[y1]) [x1] =
             (_GL_RAWPTR p->texptr->line[ (int) v]) [ (int) u];
         }
+        __glStatsAdd(ctx, pixels_written, 1)
+      }
+      else {
+        __glStatsAdd(ctx, pixels_depth, 1)
       }
 
       /* Step 1/Z, U/Z and V/Z horizontally */
@@ -272,3 +328,43 @@ __glRasterSegment (glContext *ctx, glPolygon *p, int y1, int y2)
     y1++;
   }
 }
+
+/* Second pass of deferred texturing: one texel fetch
+ * per covered pixel, regardless of the overdraw */
+GL_EXPORT(void)
+glResolve(glContext *context)
+{
+  if (!context || !context->vis_buf)
+    return;
+  if (context->state < GL_READY)
+    return;
+  __glStatsBegin(t_resolve)
+  /* Incremental, only the tiles redrawn this frame */
+  if (context->tile_buf)
+    __glTileForEach(context, __glResolveRect);
+  else
+    __glResolveRect(context, 0, 0,
+      context->vis_buf->w, context->vis_buf->h);
+  __glStatsEnd(context, cycles_resolve, t_resolve)
+}
+
+GL_INTERNAL(void)
+__glResolveRect(glContext *ctx, int x1, int y1, int x2, int y2)
+{
+  int x, y, i;
+  float z;
+  glVisibilityBuffer *vb = ctx->vis_buf;
+  for (y = y1; y < y2; ++y) {
+    i = y * vb->w + x1;
+    for (x = x1; x < x2; ++x, ++i) {
+      if (!vb->texptr[i])
+        continue;
+      /* Depth buffer holds Z of the visible surface */
+      z = ctx->depth_buf->depth[i];
+      (_GL_RAWPTR ctx->frame_buf->line[y]) [x] =
+        (_GL_RAWPTR vb->texptr[i]->line[ (int) (vb->uviz[i].y * z)])
+                                        [ (int) (vb->uviz[i].x * z)];
+      __glStatsAdd(ctx, pixels_resolved, 1)
+    }
+  }
+}
@@ -0,0 +1,291 @@
+
+/*
+ *  Graphics Library (GL) using Software Rendering (SR)
+ *  Copyright (C) Andre Caceres Carrilho, 2010-2017
+ *
+ *  This code is a minimalistic version of OpenGL aimed
+ *  at CPU-based perspective projection and rasterization
+ *  of textured triangles. The code is written only for
+ *  single-threaded usage without SIMD or SSE instructions
+ *  and does not follow Khronos Group standards
+ */
+
+/*
+ * Incremental rendering: the screen is split in tiles of
+ * GL_TILE_SIZE pixels and only the tiles invalidated since
+ * the last frame are cleared and rasterized again. Depth and
+ * color of the other tiles are retained from earlier frames.
+ *
+ * Per frame usage:
+ *   glInvalidate(ctx, obj, old_pose);  (before moving it)
+ *   glInvalidate(ctx, obj, new_pose);  (glInvalidateMesh for glMesh)
+ *   glClear(ctx);                      (pending -> active)
+ *   glLookAt(ctx, cam);                (before or after glClear)
+ *   glRender(ctx, ...);                (every object)
+ *
+ * A camera change invalidates the whole screen at once, so the
+ * frame is complete wherever glLookAt() sits relative to glClear().
+ */
+
+#include "gl_common.h"
+
+GL_EXPORT(glInt)
+glIncremental(glContext *context, glBool enable)
+{
+  if (!context)
+    return -1;
+  if (!enable) {
+    __glTileBufferFree(context->tile_buf);
+    context->tile_buf = GL_NULL;
+    return 0;
+  }
+  /* Needs the viewport size from glPerspective() */
+  if (context->state < GL_CREATED)
+    return -1;
+  if (context->tile_buf)
+    return 0;
+  context->tile_buf = __glTileBufferCreate(
+    context->depth_buf->w, context->depth_buf->h);
+  if (!context->tile_buf)
+    return -1;
+  return 0;
+}
+
+GL_EXPORT(void)
+glInvalidate(glContext *context, glPolygonBuffer *object, glMatrix *modelworld)
+{
+  unsigned int i;
+  int r[4];
+  if (!context || !context->tile_buf)
+    return;
+  glTileBuffer *tb = context->tile_buf;
+  /* Without an object (or a camera) the whole screen is redrawn */
+  if (!object || context->state < GL_READY) {
+    for (i = 0; i < tb->n; ++i)
+      tb->dirty[i] |= GL_TILE_PENDING;
+    return;
+  }
+  __glRenderPipeline(context, object, modelworld);
+  for (i = 0; i < object->n; ++i) {
+    if (object->polys[i].backfacing)
+      continue;
+    switch (__glTileBounds(context, &object->polys[i], r)) {
+    case -1: /* Crossing the near plane, no reliable bounds */
+      glInvalidate(context, GL_NULL, GL_NULL);
+      return;
+    case 1:
+      __glTileMark(tb, r);
+      break;
+    }
+  }
+}
+
+/* Marks the screen footprint of the mesh bounding sphere,
+ * the view space box around it is projected by its corners */
+GL_EXPORT(void)
+glInvalidateMesh(glContext *context, glMesh *mesh, glMatrix *modelworld)
+{
+  unsigned int k;
+  int r[4];
+  float radius, x, y, x1, y1, x2, y2;
+  glVector3f c;
+  if (!context || !context->tile_buf)
+    return;
+  if (!mesh || context->state < GL_READY) {
+    glInvalidate(context, GL_NULL, GL_NULL);
+    return;
+  }
+  glFrustum *ft = context->frustum;
+  radius = __glMeshSphere(context, mesh, modelworld, &c);
+  /* Crossing the near plane, no reliable bounds */
+  if (!(c.z - radius > ft->plane[GL_PLANE_NEAR])) {
+    glInvalidate(context, GL_NULL, GL_NULL);
+    return;
+  }
+  x1 = y1 = 3.4e38f;
+  x2 = y2 = -3.4e38f;
+  for (k = 0; k < 4; ++k) {
+    float z = c.z + ((k & 2) ? radius : -radius);
+    x = (c.x + ((k & 1) ? radius : -radius)) / z;
+    y = (c.y + ((k & 1) ? radius : -radius)) / z;
+    if (x < x1) x1 = x;
+    if (x > x2) x2 = x;
+    if (y < y1) y1 = y;
+    if (y > y2) y2 = y;
+  }
+  x1 = x1 * ft->plane[GL_PLANE_PROJECTION] + ft->center.x;
+  x2 = x2 * ft->plane[GL_PLANE_PROJECTION] + ft->center.x;
+  y1 = y1 * ft->plane[GL_PLANE_PROJECTION] + ft->center.y;
+  y2 = y2 * ft->plane[GL_PLANE_PROJECTION] + ft->center.y;
+  if (__glTileRect(context, x1, y1, x2, y2, r))
+    __glTileMark(context->tile_buf, r);
+}
+
+/* Screen bounds of a projected polygon in tile coordinates,
+ * r = {x1, y1, x2, y2} (inclusive). Returns 0 if offscreen,
+ * -1 if any vertex is not in front of the near plane */
+GL_INTERNAL(glInt)
+__glTileBounds(glContext *ctx, glPolygon *p, int *r)
+{
+  unsigned int j;
+  float x1, y1, x2, y2;
+  for (j = 0; j < 3; ++j) {
+    if (!(p->verts[j].screen.z > ctx->frustum->plane[GL_PLANE_NEAR]))
+      return -1;
+  }
+  x1 = x2 = p->verts[0].screen.x;
+  y1 = y2 = p->verts[0].screen.y;
+  for (j = 1; j < 3; ++j) {
+    if (p->verts[j].screen.x < x1) x1 = p->verts[j].screen.x;
+    if (p->verts[j].screen.x > x2) x2 = p->verts[j].screen.x;
+    if (p->verts[j].screen.y < y1) y1 = p->verts[j].screen.y;
+    if (p->verts[j].screen.y > y2) y2 = p->verts[j].screen.y;
+  }
+  return __glTileRect(ctx, x1, y1, x2, y2, r);
+}
+
+/* Screen rect in pixels to tile coordinates, r = {x1, y1, x2, y2}
+ * (inclusive). Returns 0 if the rect is offscreen */
+GL_INTERNAL(glInt)
+__glTileRect(glContext *ctx, float x1, float y1, float x2, float y2, int *r)
+{
+  float w = (float) ctx->depth_buf->w;
+  float h = (float) ctx->depth_buf->h;
+  /* Pixel margins, the rasterizer truncates the
+   * edges after the (+0.5, +0.5) subpixel shift */
+  x1 -= 1.0f; y1 -= 1.0f;
+  x2 += 2.0f; y2 += 2.0f;
+  if (x2 < 0.0f || y2 < 0.0f || x1 >= w || y1 >= h)
+    return 0;
+  if (x1 < 0.0f) x1 = 0.0f;
+  if (y1 < 0.0f) y1 = 0.0f;
+  if (x2 > w - 1.0f) x2 = w - 1.0f;
+  if (y2 > h - 1.0f) y2 = h - 1.0f;
+  r[0] = (int) x1 >> GL_TILE_SHIFT;
+  r[1] = (int) y1 >> GL_TILE_SHIFT;
+  r[2] = (int) x2 >> GL_TILE_SHIFT;
+  r[3] = (int) y2 >> GL_TILE_SHIFT;
+  return 1;
+}
+
+GL_INTERNAL(void)
+__glTileMark(glTileBuffer *tb, int *r)
+{
+  int tx, ty;
+  for (ty = r[1]; ty <= r[3]; ++ty) {
+    for (tx = r[0]; tx <= r[2]; ++tx)
+      tb->dirty[ty * tb->w + tx] |= GL_TILE_PENDING;
+  }
+}
+
+/* Whether the polygon touches any tile redrawn this frame.
+ * Polygons spilling over clean tiles are still rasterized
+ * there, which is harmless: the retained depth already holds
+ * the same surfaces and the (strict) depth test rejects them */
+GL_INTERNAL(glBool)
+__glTileTest(glContext *ctx, glPolygon *p)
+{
+  int tx, ty, r[4];
+  glTileBuffer *tb = ctx->tile_buf;
+  switch (__glTileBounds(ctx, p, r)) {
+  case -1:
+    return 1;
+  case 0:
+    return 0;
+  }
+  for (ty = r[1]; ty <= r[3]; ++ty) {
+    for (tx = r[0]; tx <= r[2]; ++tx) {
+      if (tb->dirty[ty * tb->w + tx] & GL_TILE_ACTIVE)
+        return 1;
+    }
+  }
+  __glStatsAdd(ctx, tris_clean, 1)
+  return 0;
+}
+
+/* Calls fn(ctx, x1, y1, x2, y2) for every horizontal run
+ * of active tiles, in pixels (x2 and y2 exclusive) */
+GL_INTERNAL(void)
+__glTileForEach(glContext *ctx, void (*fn)(glContext*, int, int, int, int))
+{
+  unsigned int tx, ty, run;
+  int x1, y1, x2, y2;
+  glTileBuffer *tb = ctx->tile_buf;
+  for (ty = 0; ty < tb->h; ++ty) {
+    y1 = ty << GL_TILE_SHIFT;
+    y2 = y1 + GL_TILE_SIZE;
+    if (y2 > (int) ctx->depth_buf->h)
+      y2 = ctx->depth_buf->h;
+    for (tx = 0; tx < tb->w; tx = run) {
+      if (!(tb->dirty[ty * tb->w + tx] & GL_TILE_ACTIVE)) {
+        run = tx + 1;
+        continue;
+      }
+      for (run = tx + 1; run < tb->w; ++run) {
+        if (!(tb->dirty[ty * tb->w + run] & GL_TILE_ACTIVE))
+          break;
+      }
+      x1 = tx << GL_TILE_SHIFT;
+      x2 = run << GL_TILE_SHIFT;
+      if (x2 > (int) ctx->depth_buf->w)
+        x2 = ctx->depth_buf->w;
+      fn(ctx, x1, y1, x2, y2);
+    }
+  }
+}
+
+/* Starts a new frame: the pending tiles become active
+ * and are cleared, every other tile keeps its pixels */
+GL_INTERNAL(void)
+__glClearTiles(glContext *ctx)
+{
+  unsigned int i;
+  glTileBuffer *tb = ctx->tile_buf;
+  for (i = 0; i < tb->n; ++i)
+    tb->dirty[i] = (tb->dirty[i] & GL_TILE_PENDING) ? GL_TILE_ACTIVE : 0;
+  __glTileForEach(ctx, __glClearRect);
+}
+
+/* Camera changed: every tile is cleared and redrawn in the
+ * current frame (active) and, when glClear() comes afterwards,
+ * stays redrawn in the frame it starts (pending) */
+GL_INTERNAL(void)
+__glTileRedrawAll(glContext *ctx)
+{
+  unsigned int i;
+  glTileBuffer *tb = ctx->tile_buf;
+  for (i = 0; i < tb->n; ++i)
+    tb->dirty[i] = GL_TILE_PENDING | GL_TILE_ACTIVE;
+  __glTileForEach(ctx, __glClearRect);
+}
+
+GL_INTERNAL(glTileBuffer*)
+__glTileBufferCreate(glSize w, glSize h)
+{
+  unsigned int i;
+  glTileBuffer *tb = (glTileBuffer*) malloc(sizeof(glTileBuffer));
+  if (!tb)
+    return GL_NULL;
+  tb->w = (w + GL_TILE_SIZE - 1) >> GL_TILE_SHIFT;
+  tb->h = (h + GL_TILE_SIZE - 1) >> GL_TILE_SHIFT;
+  tb->n = tb->w * tb->h; /* tile count */
+  tb->dirty = (uint8_t*) malloc(tb->n * sizeof(uint8_t));
+  if (!tb->dirty) {
+    free(tb);
+    return GL_NULL;
+  }
+  /* Nothing retained yet, the first frame is drawn entirely */
+  for (i = 0; i < tb->n; ++i)
+    tb->dirty[i] = GL_TILE_PENDING;
+  return tb;
+}
+
+GL_INTERNAL(void)
+__glTileBufferFree(glTileBuffer *tb)
+{
+  if (tb) {
+    if (tb->dirty)
+      free(tb->dirty);
+    free(tb);
+  }
+}
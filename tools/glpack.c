@@ -0,0 +1,364 @@
+/*
+ *  Graphics Library (GL) using Software Rendering (SR)
+ *  Copyright (C) Andre Caceres Carrilho, 2010-2017
+ *
+ *  This code is a minimalistic version of OpenGL aimed
+ *  at CPU-based perspective projection and rasterization
+ *  of textured triangles. The code is written only for
+ *  single-threaded usage without SIMD or SSE instructions
+ *  and does not follow Khronos Group standards
+ */
+
+/*
+ * Offline converter to the binary asset format read by glMeshLoad()
+ *
+ *   glpack <mesh.obj> <out.nga> [texture.bmp|pcx|tga] [mip levels]
+ *
+ * OBJ faces are triangulated as fans and every distinct (v, vt)
+ * pair becomes one indexed vertex. The rasterizer does not wrap
+ * texture coords, so vt values outside [0,1] (tiled textures)
+ * are clamped, with a warning naming the first offending line. The texture is converted to
+ * the GL_COLOR_DEPTH pixel format and box filtered into a chain
+ * of mip levels (a single level by default).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../gl_common.h"
+
+typedef struct {
+  float *pos;  /* v, 3 floats each */
+  float *uv;   /* vt, 2 floats each */
+  glSize npos, nuv, cpos, cuv;
+  glMeshVertex *verts;
+  uint32_t *index;
+  glSize nverts, nindex, cverts, cindex;
+  /* (v, vt) pair -> vertex, open addressing */
+  int32_t *key;
+  uint32_t *val;
+  glSize hsize;
+} glpackMesh;
+
+#define _GLPACK_GROW(ptr, n, cap, k) \
+  if ((n) + (k) > (cap)) { \
+    (cap) = ((n) + (k)) * 2; \
+    (ptr) = realloc((ptr), (cap) * sizeof(*(ptr))); \
+    if (!(ptr)) { fprintf(stderr, "glpack: out of memory\n"); exit(1); } \
+  }
+
+static float
+glpackClamp(float x)
+{
+  return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+}
+
+static void
+glpackRehash(glpackMesh *m, glSize size)
+{
+  glSize i, h;
+  int32_t *key = m->key;
+  uint32_t *val = m->val;
+  glSize old = m->hsize;
+  m->hsize = size;
+  m->key = malloc(size * 2 * sizeof(int32_t));
+  m->val = malloc(size * sizeof(uint32_t));
+  if (!m->key || !m->val) {
+    fprintf(stderr, "glpack: out of memory\n");
+    exit(1);
+  }
+  for (i = 0; i < size; ++i)
+    m->key[i * 2] = -1;
+  for (i = 0; i < old; ++i) {
+    if (key[i * 2] < 0)
+      continue;
+    h = ((uint32_t) key[i * 2] * 2654435761u ^
+         (uint32_t) key[i * 2 + 1] * 40503u) & (size - 1);
+    while (m->key[h * 2] >= 0)
+      h = (h + 1) & (size - 1);
+    m->key[h * 2] = key[i * 2];
+    m->key[h * 2 + 1] = key[i * 2 + 1];
+    m->val[h] = val[i];
+  }
+  free(key);
+  free(val);
+}
+
+/* Index of the vertex made of position vi and texcoord ti
+ * (-1 when the face has no vt), created on first use */
+static uint32_t
+glpackVertex(glpackMesh *m, int32_t vi, int32_t ti)
+{
+  glSize h;
+  if (m->nverts * 2 >= m->hsize)
+    glpackRehash(m, m->hsize ? m->hsize * 2 : 1024);
+  h = ((uint32_t) vi * 2654435761u ^ (uint32_t) ti * 40503u) & (m->hsize - 1);
+  while (m->key[h * 2] >= 0) {
+    if (m->key[h * 2] == vi && m->key[h * 2 + 1] == ti)
+      return m->val[h];
+    h = (h + 1) & (m->hsize - 1);
+  }
+  m->key[h * 2] = vi;
+  m->key[h * 2 + 1] = ti;
+  m->val[h] = m->nverts;
+  _GLPACK_GROW(m->verts, m->nverts, m->cverts, 1)
+  glMeshVertex *v = &m->verts[m->nverts];
+  v->pos.x = m->pos[vi * 3];
+  v->pos.y = m->pos[vi * 3 + 1];
+  v->pos.z = m->pos[vi * 3 + 2];
+  /* OBJ V axis points up, texture rows go down */
+  v->uv.x = ti < 0 ? 0.0f : glpackClamp(m->uv[ti * 2]);
+  v->uv.y = ti < 0 ? 0.0f : glpackClamp(1.0f - m->uv[ti * 2 + 1]);
+  return m->nverts++;
+}
+
+/* OBJ indices are 1-based, negative ones are relative to the end */
+static int32_t
+glpackIndex(long i, glSize n)
+{
+  if (i < 0)
+    i += (long) n + 1;
+  return (i >= 1 && i <= (long) n) ? (int32_t) (i - 1) : -1;
+}
+
+static int
+glpackLoadObj(glpackMesh *m, const char *path)
+{
+  char line[4096], *s, *end;
+  uint32_t face[3];
+  glSize k, lineno = 0, clamped = 0;
+  int32_t tex;
+  long vi, ti;
+  float *uv;
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return -1;
+  while (fgets(line, sizeof(line), f)) {
+    ++lineno;
+    if (line[0] == 'v' && line[1] == ' ') {
+      _GLPACK_GROW(m->pos, m->npos * 3, m->cpos, 3)
+      if (sscanf(line + 2, "%f %f %f", &m->pos[m->npos * 3],
+          &m->pos[m->npos * 3 + 1], &m->pos[m->npos * 3 + 2]) != 3) {
+        fprintf(stderr, "glpack: %s:%u: bad vertex\n",
+          path, (unsigned) lineno);
+        fclose(f);
+        return -1;
+      }
+      m->npos++;
+    } else if (line[0] == 'v' && line[1] == 't' && line[2] == ' ') {
+      _GLPACK_GROW(m->uv, m->nuv * 2, m->cuv, 2)
+      uv = &m->uv[m->nuv * 2];
+      /* V is optional in OBJ and defaults to 0 */
+      uv[0] = uv[1] = 0.0f;
+      if (sscanf(line + 3, "%f %f", &uv[0], &uv[1]) < 1) {
+        fprintf(stderr, "glpack: %s:%u: bad texcoord\n",
+          path, (unsigned) lineno);
+        fclose(f);
+        return -1;
+      }
+      if (uv[0] < 0.0f || uv[0] > 1.0f || uv[1] < 0.0f || uv[1] > 1.0f) {
+        if (!clamped++)
+          fprintf(stderr, "glpack: %s:%u: warning: texcoord outside "
+            "[0,1] clamped, tiling is not supported\n",
+            path, (unsigned) lineno);
+      }
+      m->nuv++;
+    } else if (line[0] == 'f' && line[1] == ' ') {
+      /* Tokens v, v/vt, v/vt/vn or v//vn, fan triangulated */
+      for (s = line + 2, k = 0; ; ++k) {
+        vi = strtol(s, &end, 10);
+        if (end == s)
+          break;
+        s = end;
+        tex = -1;
+        if (*s == '/') {
+          ti = strtol(++s, &end, 10);
+          /* Empty in v//vn, otherwise it must be valid */
+          if (end != s) {
+            tex = glpackIndex(ti, m->nuv);
+            if (tex < 0) {
+              fprintf(stderr, "glpack: %s:%u: bad texcoord index\n",
+                path, (unsigned) lineno);
+              fclose(f);
+              return -1;
+            }
+          }
+          s = end;
+          if (*s == '/')
+            strtol(++s, &s, 10);
+        }
+        if (glpackIndex(vi, m->npos) < 0) {
+          fprintf(stderr, "glpack: %s:%u: bad vertex index\n",
+            path, (unsigned) lineno);
+          fclose(f);
+          return -1;
+        }
+        face[k < 2 ? k : 2] = glpackVertex(m, glpackIndex(vi, m->npos), tex);
+        if (k >= 2) {
+          _GLPACK_GROW(m->index, m->nindex, m->cindex, 3)
+          m->index[m->nindex++] = face[0];
+          m->index[m->nindex++] = face[1];
+          m->index[m->nindex++] = face[2];
+          face[1] = face[2];
+        }
+      }
+    }
+  }
+  fclose(f);
+  if (clamped > 1)
+    fprintf(stderr, "glpack: %s: warning: %u texcoords clamped\n",
+      path, (unsigned) clamped);
+  return 0;
+}
+
+/* 2x2 box filter of the previous level */
+static BITMAP*
+glpackMipLevel(BITMAP *src)
+{
+  int x, y, i, r, g, b, sx, sy;
+  int w = src->w > 1 ? src->w / 2 : 1;
+  int h = src->h > 1 ? src->h / 2 : 1;
+  BITMAP *dst = create_bitmap_ex(GL_COLOR_DEPTH, w, h);
+  if (!dst)
+    return GL_NULL;
+  for (y = 0; y < h; ++y) {
+    for (x = 0; x < w; ++x) {
+      r = g = b = 0;
+      for (i = 0; i < 4; ++i) {
+        sx = x * 2 + (i & 1);
+        sy = y * 2 + (i >> 1);
+        if (sx >= src->w) sx = src->w - 1;
+        if (sy >= src->h) sy = src->h - 1;
+        int c = getpixel(src, sx, sy);
+        r += getr_depth(GL_COLOR_DEPTH, c);
+        g += getg_depth(GL_COLOR_DEPTH, c);
+        b += getb_depth(GL_COLOR_DEPTH, c);
+      }
+      putpixel(dst, x, y, makecol_depth(GL_COLOR_DEPTH,
+        (r + 2) / 4, (g + 2) / 4, (b + 2) / 4));
+    }
+  }
+  return dst;
+}
+
+int
+main(int argc, char **argv)
+{
+  glpackMesh m;
+  glAssetHeader hd;
+  BITMAP *level[16];
+  glSize i, levels = 0, pitch;
+  static const char pad[4] = { 0, 0, 0, 0 };
+  FILE *f;
+  if (argc < 3 || argc > 5) {
+    fprintf(stderr, "usage: glpack <mesh.obj> <out.nga> "
+                    "[texture.bmp|pcx|tga] [mip levels]\n");
+    return 1;
+  }
+  memset(&m, 0, sizeof(m));
+  if (glpackLoadObj(&m, argv[1])) {
+    fprintf(stderr, "glpack: can not read %s\n", argv[1]);
+    return 1;
+  }
+  if (!m.nindex) {
+    fprintf(stderr, "glpack: %s: no faces\n", argv[1]);
+    return 1;
+  }
+  memset(&hd, 0, sizeof(hd));
+  memcpy(hd.magic, GL_ASSET_MAGIC, 4);
+  hd.version = GL_ASSET_VERSION;
+  hd.nverts = m.nverts;
+  hd.ntris = m.nindex / 3;
+  /* *********************************
+   * Bounds (box and sphere)
+   * *********************************/
+  if (m.nverts) {
+    hd.bounds_min = hd.bounds_max = m.verts[0].pos;
+  }
+  for (i = 1; i < m.nverts; ++i) {
+#define _GLPACK_MINMAX(c) \
+    if (m.verts[i].pos.c < hd.bounds_min.c) hd.bounds_min.c = m.verts[i].pos.c; \
+    if (m.verts[i].pos.c > hd.bounds_max.c) hd.bounds_max.c = m.verts[i].pos.c;
+    _GLPACK_MINMAX(x)
+    _GLPACK_MINMAX(y)
+    _GLPACK_MINMAX(z)
+#undef _GLPACK_MINMAX
+  }
+  hd.center.x = (hd.bounds_min.x + hd.bounds_max.x) * 0.5f;
+  hd.center.y = (hd.bounds_min.y + hd.bounds_max.y) * 0.5f;
+  hd.center.z = (hd.bounds_min.z + hd.bounds_max.z) * 0.5f;
+  for (i = 0; i < m.nverts; ++i) {
+    glVector3f d;
+    __glMathSubtract(d, m.verts[i].pos, hd.center)
+    float r = sqrtf(__glMathDotProduct(d, d));
+    if (r > hd.radius)
+      hd.radius = r;
+  }
+  /* *********************************
+   * Texture and mip chain
+   * *********************************/
+  if (argc >= 4) {
+    allegro_init();
+    set_color_depth(GL_COLOR_DEPTH);
+    set_color_conversion(COLORCONV_TOTAL);
+    level[0] = load_bitmap(argv[3], GL_NULL);
+    if (!level[0] || bitmap_color_depth(level[0]) != GL_COLOR_DEPTH) {
+      fprintf(stderr, "glpack: can not read %s\n", argv[3]);
+      return 1;
+    }
+    levels = argc == 5 ? (glSize) atoi(argv[4]) : 1;
+    if (levels < 1)
+      levels = 1;
+    if (levels > 16)
+      levels = 16;
+    for (i = 1; i < levels; ++i) {
+      level[i] = glpackMipLevel(level[i - 1]);
+      if (!level[i]) {
+        fprintf(stderr, "glpack: out of memory\n");
+        return 1;
+      }
+    }
+    hd.tex_w = level[0]->w;
+    hd.tex_h = level[0]->h;
+    hd.tex_bpp = GL_COLOR_DEPTH;
+    hd.tex_levels = levels;
+  }
+  /* *********************************
+   * Layout, 4-byte aligned sections
+   * *********************************/
+  hd.verts_offset = (sizeof(hd) + 3) & ~3u;
+  hd.index_offset = hd.verts_offset + m.nverts * sizeof(glMeshVertex);
+  hd.tex_offset = hd.index_offset + m.nindex * sizeof(uint32_t);
+  f = fopen(argv[2], "wb");
+  if (!f) {
+    fprintf(stderr, "glpack: can not write %s\n", argv[2]);
+    return 1;
+  }
+  fwrite(&hd, sizeof(hd), 1, f);
+  fwrite(pad, 1, hd.verts_offset - sizeof(hd), f);
+  fwrite(m.verts, sizeof(glMeshVertex), m.nverts, f);
+  fwrite(m.index, sizeof(uint32_t), m.nindex, f);
+  for (i = 0; i < levels; ++i) {
+    int y;
+    pitch = level[i]->w * (GL_COLOR_DEPTH / 8);
+    for (y = 0; y < level[i]->h; ++y)
+      fwrite(level[i]->line[y], 1, pitch, f);
+    fwrite(pad, 1, (4 - (pitch * level[i]->h) % 4) % 4, f);
+  }
+  if (fclose(f)) {
+    fprintf(stderr, "glpack: can not write %s\n", argv[2]);
+    return 1;
+  }
+  printf("%s: %u vertices, %u triangles, %u texture levels\n",
+    argv[2], (unsigned) hd.nverts, (unsigned) hd.ntris, (unsigned) levels);
+  for (i = 0; i < levels; ++i)
+    destroy_bitmap(level[i]);
+  free(m.pos);
+  free(m.uv);
+  free(m.verts);
+  free(m.index);
+  free(m.key);
+  free(m.val);
+  return 0;
+}
+END_OF_MAIN()